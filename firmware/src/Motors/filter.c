@@ -8,8 +8,9 @@
 
 #define TC2_BASE_CLOCK 3000000  // TC2 module clock source (verify in the MCC configuration))
 #define TC2_FREQ 96000          // TC2 scaled period
+#define TC2_TICK_PERIOD (TC2_BASE_CLOCK / TC2_FREQ) // TC2 compare value of a single tick
 
-#define STEPs_TO_PERIOD(speed,mode) (( ( TC2_FREQ / ( 2 * MICROSTEP(mode)) )  / (speed)) - 1) // Converts Step/second to period pulses
+#define STEPs_TO_PERIOD(speed,mode) (( ( TC2_FREQ / MICROSTEP(mode) )  / (speed)) - 1) // Converts Step/second to period pulses (one tick per step)
 #define TIME_ms_TO_RAMP(ms) (ms * TC2_FREQ/ 2000) // Converts ms acceleration in ramp period
 
 // Defines the motor performances
@@ -21,6 +22,8 @@
 #define FILTER_DIRECTION_HOME MOT_DIRCW
 #define FILTER_DIRECTION_FIELD MOT_DIRCCW
 
+static MOTOR_STRUCT_t* const pFilterMotorStruct = &filterMotorStruct; // Motor handled by the TC2 timer
+
 static bool command_activated = false;
 static int  current_index = -1;
 static int  target_index = -1;
@@ -50,7 +53,7 @@ void filterInit(void){
     // TC2 Setup
     TC2_CompareCallbackRegister(filterCallback, 0);// Registers the working callback to the TC2 timer
     TC2_CompareStop();    
-    TC2_Compare16bitPeriodSet((long) TC2_BASE_CLOCK / (long) TC2_FREQ);
+    TC2_Compare16bitPeriodSet(TC2_TICK_PERIOD);
     
     
     // Sets the Motor performances
@@ -120,7 +123,8 @@ _MOTOR_COMMAND_RETURN_t activateFilter(int index, bool force){
     SystemStatusRegister.format_filter_index = target_index;
     encodeStatusRegister(&SystemStatusRegister);
      
-    // Initializes the position procedures
+    // Initializes the position procedures: the first timer event is generated after a single tick
+    motorTimerSchedule(TC2_REGS, TC2_TICK_PERIOD, 1);
     activationInitialize(&filterMotorStruct, true);
     return MOT_RET_STARTED;
 }
@@ -135,8 +139,15 @@ _MOTOR_COMMAND_RETURN_t activateFilter(int index, bool force){
 void filterCallback(TC_COMPARE_STATUS status, uintptr_t context){
    
     filterPositioning(&filterMotorStruct);   
+    
+    // Completes the step pulses generated in this event
+    motorStepComplete(&pFilterMotorStruct, 1);
    
-    if(filterMotorStruct.command_running) return;
+    if(filterMotorStruct.command_running){
+        // Schedules the next event
+        motorTimerSchedule(TC2_REGS, TC2_TICK_PERIOD, motorProfileSchedule(&pFilterMotorStruct, 1));
+        return;
+    }
     TC2_CompareStop(); 
     
     if(filterMotorStruct.command_error ){
@@ -175,21 +186,8 @@ void filterPositioning(MOTOR_STRUCT_t* pMotor){
    // Returns if not running (already terminated the positioning or not used)
     if(!pMotor->command_running) return;
    
-   // The falling edge of the step is not counted
-   if(pMotor->step_polarity) {
-       motorStep(pMotor, false);
-       return ;
-   }
-
     // Ramp/Speed handling: if the scheduled time is not expired no action will be taken
-    if(pMotor->time_count >= pMotor->period){
-       pMotor->time_count = 0; 
-       pMotor->period-=pMotor->ramp_rate;
-       if(pMotor->period <= pMotor->run_period) pMotor->period = pMotor->run_period;
-    }else{ 
-        pMotor->time_count++;
-        return ;
-    }
+    if(!motorProfileUpdate(pMotor)) return;
    
    switch(pMotor->command_sequence){
        case 1: 
@@ -231,6 +229,9 @@ void filterPositioning(MOTOR_STRUCT_t* pMotor){
             // Target reached
             if((blades >= min_slot) && (blades <= max_slot)){                
                 pMotor->command_sequence = 5;
+                
+                // The target move length is known: the profile can decelerate
+                pMotor->move_steps = pMotor->target_steps;
                 return;
             }
             
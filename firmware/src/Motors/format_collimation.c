@@ -8,8 +8,9 @@
 
 #define TC1_BASE_CLOCK 3000000  // TC1 module clock source (verify in the MCC configuration))
 #define TC1_FREQ 96000          // TC1 scaled period
+#define TC1_TICK_PERIOD (TC1_BASE_CLOCK / TC1_FREQ) // TC1 compare value of a single tick
 
-#define STEPs_TO_PERIOD(speed,mode) (( ( TC1_FREQ / ( 2 * MICROSTEP(mode)) )  / (speed)) - 1) // Converts Step/second to period pulses
+#define STEPs_TO_PERIOD(speed,mode) (( ( TC1_FREQ / MICROSTEP(mode) )  / (speed)) - 1) // Converts Step/second to period pulses (one tick per step)
 #define TIME_ms_TO_RAMP(ms) (ms * TC1_FREQ/ 2000) // Converts ms acceleration in ramp period
 
 // Defines the motor performances
@@ -36,6 +37,9 @@
 #define MAX_LR_STEPS_SUM 10000 // The maximum sum from the positions to prevent left and right contact
 #define MAX_LR_STEPS 8000     // The maximum position for both left and right
 
+#define BLADE_MOTORS 5 // Number of motors handled by the TC1 timer
+static MOTOR_STRUCT_t* const bladeMotors[BLADE_MOTORS] = {&leftMotorStruct, &rightMotorStruct, &backMotorStruct, &frontMotorStruct, &trapMotorStruct};
+
 static bool command_activated = false;
 static int  current_index = -1;
 static int  target_index = -1;
@@ -43,6 +47,7 @@ static int  target_index = -1;
 
 static void formatCallback(TC_COMPARE_STATUS status, uintptr_t context); //!< Timer Callback for the format collimation
 static void motorPositioning(MOTOR_STRUCT_t* pMotor);
+static void bladeActivation(MOTOR_STRUCT_t* pMotor, bool home, bool start_tc); //!< Starts the positioning of a blade
 
 
 /**
@@ -64,7 +69,7 @@ void formatInit(void){
     // TC1 Setup
     TC1_CompareCallbackRegister(formatCallback, 0);// Registers the working callback to the TC1 timer
     TC1_CompareStop();    
-    TC1_Compare16bitPeriodSet((long) TC1_BASE_CLOCK / (long) TC1_FREQ);
+    TC1_Compare16bitPeriodSet(TC1_TICK_PERIOD);
     
     
     // Sets the Motor performances
@@ -130,10 +135,44 @@ void formatInit(void){
 }
 
 
-_MOTOR_COMMAND_RETURN_t activateFormatCollimation(int index){
+/**
+ * This function starts the activation of a blade.
+ * 
+ * If the blade position is valid, and the zero setting is not requested, 
+ * the blade is directly moved from the current position 
+ * to the target position. 
+ * 
+ * Otherwise the blade executes the complete zero setting 
+ * before to reach the target position.
+ * 
+ * @param pMotor pointer to the blade motor structure
+ * @param home true if the zero setting shall be executed
+ * @param start_tc true if the TC1 timer shall be started
+ */
+void bladeActivation(MOTOR_STRUCT_t* pMotor, bool home, bool start_tc){
+    if((home) || (!pMotor->position_valid)) activationInitialize(pMotor, start_tc);
+    else activationPosition(pMotor, 4, start_tc);
+}
+
+/**
+ * This function activates the format collimation to a target format index.
+ * 
+ * The zero setting of the blades is executed only if the 
+ * blade position is not valid (after the power-up or an error condition) 
+ * or if it is explicitly requested with the home parameter.
+ * 
+ * The blades directly moving to the target are synchronized 
+ * in order to reach the target at the same time 
+ * (see the motorSynchronize() function).
+ * 
+ * @param index this is the target format index
+ * @param home true if the zero setting shall be executed in any case
+ * @return the command return code 
+ */
+_MOTOR_COMMAND_RETURN_t activateFormatCollimation(int index, bool home){
     
     // The current index is equal to the requested index
-    if(current_index == index) return MOT_RET_IN_TARGET;
+    if((!home) && (current_index == index)) return MOT_RET_IN_TARGET;
     
     // A command is executing
     if(command_activated) return MOT_RET_ERR_BUSY;    
@@ -161,13 +200,19 @@ _MOTOR_COMMAND_RETURN_t activateFormatCollimation(int index){
     SystemStatusRegister.format_selected_index = target_index;
     encodeStatusRegister(&SystemStatusRegister);
         
+    // The first timer event is generated after a single tick
+    motorTimerSchedule(TC1_REGS, TC1_TICK_PERIOD, 1);
+    
     // Initializes the position procedures
-    activationInitialize(&leftMotorStruct, false);
-    activationInitialize(&rightMotorStruct, false);
-    activationInitialize(&backMotorStruct, false);
-    activationInitialize(&leftMotorStruct, false);
-    activationInitialize(&frontMotorStruct, true);
-    //activationInitialize(&trapMotorStruct, true);
+    bladeActivation(&leftMotorStruct, home, false);
+    bladeActivation(&rightMotorStruct, home, false);
+    bladeActivation(&backMotorStruct, home, false);
+    bladeActivation(&frontMotorStruct, home, false);
+    //bladeActivation(&trapMotorStruct, home, false);
+    
+    // The blades moving directly to the target arrive at the same time
+    motorSynchronize(bladeMotors, BLADE_MOTORS);
+    TC1_CompareStart();
     
     return MOT_RET_STARTED;
 }
@@ -180,7 +225,7 @@ _MOTOR_COMMAND_RETURN_t activateFormatCollimation(int index){
  * 
  */
 void formatCallback(TC_COMPARE_STATUS status, uintptr_t context){
-   
+    int ticks;
     
     motorPositioning(&leftMotorStruct);   
     motorPositioning(&rightMotorStruct);
@@ -188,12 +233,15 @@ void formatCallback(TC_COMPARE_STATUS status, uintptr_t context){
     motorPositioning(&frontMotorStruct);
     motorPositioning(&trapMotorStruct);
     
-    if(leftMotorStruct.command_running) return;
-    if(rightMotorStruct.command_running) return;
-    if(backMotorStruct.command_running) return;
-    if(frontMotorStruct.command_running) return;
-    if(trapMotorStruct.command_running) return;
-       
+    // Completes the step pulses generated in this event
+    motorStepComplete(bladeMotors, BLADE_MOTORS);
+    
+    // Schedules the next event of the running blades
+    ticks = motorProfileSchedule(bladeMotors, BLADE_MOTORS);
+    if(ticks){
+        motorTimerSchedule(TC1_REGS, TC1_TICK_PERIOD, ticks);
+        return;
+    }
     
     TC1_CompareStop(); 
     if( (leftMotorStruct.command_error + 
@@ -237,21 +285,8 @@ void motorPositioning(MOTOR_STRUCT_t* pMotor){
     // Returns if not running (already terminated the positioning or not used)
     if(!pMotor->command_running) return;
    
-   // The falling edge of the step is not counted
-   if(pMotor->step_polarity) {
-       motorStep(pMotor, false);
-       return ;
-   }
-
     // Ramp/Speed handling: if the scheduled time is not expired no action will be taken
-    if(pMotor->time_count >= pMotor->period){
-       pMotor->time_count = 0; 
-       pMotor->period-=pMotor->ramp_rate;
-       if(pMotor->period <= pMotor->run_period) pMotor->period = pMotor->run_period;
-    }else{ 
-        pMotor->time_count++;
-        return ;
-    }
+    if(!motorProfileUpdate(pMotor)) return;
 
    switch(pMotor->command_sequence){
        
@@ -288,6 +323,13 @@ void motorPositioning(MOTOR_STRUCT_t* pMotor){
             if(!optoGet(pMotor)){
                 pMotor->command_sequence++;
                 pMotor->steps = 0;
+                
+                // The photocell exit edge is the zero reference of the absolute position
+                pMotor->position = 0;
+                pMotor->position_valid = true;
+                
+                // The target move length is known: the profile can decelerate
+                pMotor->move_steps = pMotor->target_steps;
                 return ;
             }
             
@@ -299,9 +341,15 @@ void motorPositioning(MOTOR_STRUCT_t* pMotor){
             return ;
             
        case 4: // Steps to the requested target
+            if(!isLatched(pMotor)) return ;
             
             // Command successfully completed
-            if(pMotor->steps >= pMotor->target_steps){
+            if(pMotor->direction == pMotor->direction_field){
+                if(pMotor->position >= pMotor->target_steps){
+                    pMotor->command_sequence++;
+                    return;
+                }
+            }else if(pMotor->position <= pMotor->target_steps){
                 pMotor->command_sequence++;
                 return;
             }
@@ -319,7 +367,7 @@ void motorPositioning(MOTOR_STRUCT_t* pMotor){
            
                 // Keeps the torque to dissipate the rotating energy inertia
                 if(pMotor->command_sequence > 500){
-                     motorDisable(pMotor);
+                     motorRelease(pMotor);
                      pMotor->command_error = 0;
                      pMotor->command_running = false;
                      pMotor->command_sequence = 0;
@@ -17,7 +17,7 @@
 #endif
 
         ext void formatInit(void); //!< Module initialization function
-        ext _MOTOR_COMMAND_RETURN_t activateFormatCollimation(int index);//!< format activation command to index 
+        ext _MOTOR_COMMAND_RETURN_t activateFormatCollimation(int index, bool home);//!< format activation command to index 
         ext _MOTOR_COMMAND_RETURN_t activateMotorCollimation(unsigned short steps, MOTOR_STRUCT_t* pMotor);
         
 
@@ -8,8 +8,9 @@
 
 #define TC3_BASE_CLOCK 3000000  // TC3 module clock source (verify in the MCC configuration))
 #define TC3_FREQ 96000          // TC3 scaled period
+#define TC3_TICK_PERIOD (TC3_BASE_CLOCK / TC3_FREQ) // TC3 compare value of a single tick
 
-#define STEPs_TO_PERIOD(speed,mode) (( ( TC3_FREQ / ( 2 * MICROSTEP(mode)) )  / (speed)) - 1) // Converts Step/second to period pulses
+#define STEPs_TO_PERIOD(speed,mode) (( ( TC3_FREQ / MICROSTEP(mode) )  / (speed)) - 1) // Converts Step/second to period pulses (one tick per step)
 #define TIME_ms_TO_RAMP(ms) (ms * TC3_FREQ/ 2000) // Converts ms acceleration in ramp period
 
 // Defines the motor performances
@@ -21,6 +22,8 @@
 #define MIRROR_DIRECTION_HOME MOT_DIRCCW
 #define MIRROR_DIRECTION_FIELD MOT_DIRCW
 
+static MOTOR_STRUCT_t* const pMirrorMotorStruct = &mirrorMotorStruct; // Motor handled by the TC3 timer
+
 static bool command_activated = false;
 static int  current_index = -1;
 static int  target_index = -1;
@@ -48,7 +51,7 @@ void mirrorInit(void){
     // TC3 Setup
     TC3_CompareCallbackRegister(mirrorCallback, 0);// Registers the working callback to the TC3 timer
     TC3_CompareStop();    
-    TC3_Compare16bitPeriodSet((long) TC3_BASE_CLOCK / (long) TC3_FREQ);
+    TC3_Compare16bitPeriodSet(TC3_TICK_PERIOD);
     
     
     // Sets the Motor performances
@@ -101,7 +104,8 @@ _MOTOR_COMMAND_RETURN_t activateMirror(int index){
     SystemStatusRegister.in_field_position = target_index;
     encodeStatusRegister(&SystemStatusRegister);
      
-    // Initializes the position procedures
+    // Initializes the position procedures: the first timer event is generated after a single tick
+    motorTimerSchedule(TC3_REGS, TC3_TICK_PERIOD, 1);
     activationInitialize(&mirrorMotorStruct, true);
     return MOT_RET_STARTED;
 }
@@ -115,8 +119,15 @@ _MOTOR_COMMAND_RETURN_t activateMirror(int index){
 void mirrorCallback(TC_COMPARE_STATUS status, uintptr_t context){
    
     mirrorPositioning(&mirrorMotorStruct);   
+    
+    // Completes the step pulses generated in this event
+    motorStepComplete(&pMirrorMotorStruct, 1);
    
-    if(mirrorMotorStruct.command_running) return;
+    if(mirrorMotorStruct.command_running){
+        // Schedules the next event
+        motorTimerSchedule(TC3_REGS, TC3_TICK_PERIOD, motorProfileSchedule(&pMirrorMotorStruct, 1));
+        return;
+    }
     TC3_CompareStop(); 
     
     if(mirrorMotorStruct.command_error ){
@@ -155,21 +166,8 @@ void mirrorPositioning(MOTOR_STRUCT_t* pMotor){
     // Returns if not running (already terminated the positioning or not used)
     if(!pMotor->command_running) return;
    
-   // The falling edge of the step is not counted
-   if(pMotor->step_polarity) {
-       motorStep(pMotor, false);
-       return ;
-   }
-
     // Ramp/Speed handling: if the scheduled time is not expired no action will be taken
-    if(pMotor->time_count >= pMotor->period){
-       pMotor->time_count = 0; 
-       pMotor->period-=pMotor->ramp_rate;
-       if(pMotor->period <= pMotor->run_period) pMotor->period = pMotor->run_period;
-    }else{ 
-        pMotor->time_count++;
-        return ;
-    }
+    if(!motorProfileUpdate(pMotor)) return;
     
    switch(pMotor->command_sequence){
        
@@ -206,6 +204,9 @@ void mirrorPositioning(MOTOR_STRUCT_t* pMotor){
             if(!optoGet(pMotor)){
                 pMotor->command_sequence++;
                 pMotor->steps = 0;
+                
+                // The target move length is known: the profile can decelerate
+                pMotor->move_steps = pMotor->target_steps;
                 return ;
             }
             
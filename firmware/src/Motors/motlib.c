@@ -11,16 +11,55 @@
      * 
      *  @{
      */
-        #define LATCH_US_PULSE 10 //!< Defines the Latch pulse period in 1us units
+        #define LATCH_US_PULSE 1 //!< Defines the Latch pulse period in 1us units
         #define MOTOR_SLEEP_OFF uC_MOT_SLEEP_Set() //!<  Exit the Motor Sleep Mode macro
         #define MOTOR_SLEEP_ON uC_MOT_SLEEP_Clear() //!<  Set the Motor  Sleep Mode macro
+        
+        #define STEP_PORT_GROUPS 2 //!< Number of PORT groups with STEP pins (PA, PB)
+        #define STEP_PORT_GROUP(pin) (PORT_REGS->GROUP[(pin) >> 5]) //!< PORT group of a STEP pin
+        #define STEP_PORT_MASK(pin) ((uint32_t) 1U << ((pin) & 0x1F)) //!< Bit mask of a STEP pin into its PORT group
+        
+        //! STEP pin of every motor, addressed by the motor identifier
+        static const PORT_PIN step_pin[MOTOR_LEN] = {
+            [MOTOR_LEFT_ID] = uC_STEP_LEFT_PIN,
+            [MOTOR_RIGHT_ID] = uC_STEP_RIGHT_PIN,
+            [MOTOR_FRONT_ID] = uC_STEP_FRONT_PIN,
+            [MOTOR_BACK_ID] = uC_STEP_BACK_PIN,
+            [MOTOR_TRAP_ID] = uC_STEP_TRAP_PIN,
+            [MOTOR_FILTER_ID] = uC_STEP_FILTER_PIN,
+            [MOTOR_MIRROR_ID] = uC_STEP_MIRROR_PIN,
+        };
 
-        static volatile bool wait_flag; //!< This is the flag used for the 1us waiting routine
+        #define LATCH_BUS_SHIFT 4 //!< Position of the Motor BUS lines (uC_IA ... uC_ENASTEP) on the PORTA group
+        #define LATCH_BUS_MASK ((uint32_t) 0xFF << LATCH_BUS_SHIFT) //!< Mask of the Motor BUS lines on the PORTA group
+        
+        #define LATCH_DMA_CHANNEL 0 //!< DMAC channel of the latch sequencer
+        #define LATCH_DMA_STEPS 4 //!< Descriptors for every latched motor: bus clear, bus set, latch high, latch low
+        #define LATCH_DMA_LEN (MOTOR_LEN * LATCH_DMA_STEPS) //!< Maximum length of the latch sequence
         
+        //! Latch trigger pin of every motor, addressed by the motor identifier
+        static const PORT_PIN latch_pin[MOTOR_LEN] = {
+            [MOTOR_LEFT_ID] = uC_LATCH_LEFT_PIN,
+            [MOTOR_RIGHT_ID] = uC_LATCH_RIGHT_PIN,
+            [MOTOR_FRONT_ID] = uC_LATCH_FRONT_PIN,
+            [MOTOR_BACK_ID] = uC_LATCH_BACK_PIN,
+            [MOTOR_TRAP_ID] = uC_LATCH_TRAP_PIN,
+            [MOTOR_FILTER_ID] = uC_LATCH_FILTER_PIN,
+            [MOTOR_MIRROR_ID] = uC_LATCH_MIRROR_PIN,
+        };
         
-        static void latch_1us_callback(TC_TIMER_STATUS status, uintptr_t context); //!< This is the 1us TC0 callback routine
-        static void wait_us(unsigned short utime); //!< This is the delay routine based on the 1us TC0 interrupt
-        static void setLatch(_MOTOR_ID_t motid); //!< This is the Latch Pulse routine
+        static dmac_descriptor_registers_t latch_dma_base __ALIGNED(16); //!< DMAC first descriptor section (channel 0 only)
+        static dmac_descriptor_registers_t latch_dma_wrb __ALIGNED(16); //!< DMAC write-back section (channel 0 only)
+        static dmac_descriptor_registers_t latch_dma_list[LATCH_DMA_LEN] __ALIGNED(16); //!< Descriptor list of the latch sequence
+        static uint32_t latch_dma_data[LATCH_DMA_LEN]; //!< PORT patterns played by the latch sequence
+        
+        static volatile uint32_t latch_pending; //!< Bit mask of the motors waiting for the latch sequencer
+        static volatile uint32_t latch_running; //!< Bit mask of the motors in the running latch sequence
+        
+        static void wait_cycles(uint32_t cycles); //!< This is the delay routine based on the DWT cycle counter
+        static void latchSequencerInit(void); //!< This is the latch sequencer initialization routine
+        static void latchSequencerStart(void); //!< This is the latch sequence start routine
+        static void activationStart(MOTOR_STRUCT_t* pMotor, int sequence, MOT_DIRECTION_t dir, bool start_tc); //!< This is the common activation routine
          
     /// @}   privateModuleMembers
 
@@ -29,122 +68,176 @@
 
 
 /**
- * This callback is called after 1us from the TCO-Start event.
- * 
- * The TC0 is set to One-Shot Timer mode: when started it rise a 
- * single callback event after 1us. This callback is used to 
- * implement the wait_us routine.
+ * This is the internal delay routine with CPU cycle unit.
  * 
+ * The routine makes use of the DWT cycle counter, 
+ * free running at the CPU clock frequency:
+ * no interrupt is involved so the routine can be called 
+ * inside an interrupt routine.
  * 
- * @param status see TC_TIMER_STATUS for details. (not used)
- * @param context this is a pointer to a contest. (not used)
+ * @param cycles CPU cycles delay time
  */
-void latch_1us_callback(TC_TIMER_STATUS status, uintptr_t context){
-    wait_flag = true;  
+void wait_cycles(uint32_t cycles){
+    uint32_t start = DWT->CYCCNT;
+    while((DWT->CYCCNT - start) < cycles);
+    return;
 }
 
 /**
- * This is the internal delay routine with 1us unit.
+ * This function requests the Motor Bus data to be latched to the motor driver.
  * 
- * The routine can provide from 1 to 65536 us delay time.
+ * The motor is added to the pending latch requests and,
+ * if the latch sequencer is idle, a new latch sequence is started.
  * 
- * This routine is not reentrant so it cannot be called 
- * inside an interrupt routine.
+ * The request is completed in few microseconds without CPU activity:
+ * the isLatched() function returns true as soon as the 
+ * motor bus data are latched to the driver.
  * 
- * @param utime micro seconds delay time
+ * The function can be called either from the main loop 
+ * or from the motor timer callbacks.
+ * 
+ * @param motid this is the Motor identifier. (See _MOTOR_ID_t)
  */
-void wait_us(unsigned short utime){
-    wait_flag = false;
-    for(int i=0; i < utime; i++){
-        TC0_TimerStart();
-        while(!wait_flag);
-    }  
-    return;
-}
-
-void manageMotorLatch(void){
-    for(int i=0; i <= LAST_MOTOR_ID; i++){
-        if(!motor_latch_request[i]) continue;
-        setLatch(i);
-        motor_latch_request[i] = false;
-    }
-}
-
 void requestLatch(_MOTOR_ID_t motid){
+    bool irq = __get_PRIMASK() == 0;
+    __disable_irq();
+    
     motor_latch_request[motid] = true;
+    latch_pending |= (1U << motid);
+    if(!latch_running) latchSequencerStart();
+    
+    if(irq) __enable_irq();
 }
 
+/**
+ * This function initializes the latch sequencer.
+ * 
+ * + The TC0 is set to periodic mode with the LATCH_US_PULSE period 
+ * and its interrupt is disabled: the overflow is only used 
+ * as DMAC trigger;
+ * + The DMAC channel LATCH_DMA_CHANNEL is set to transfer
+ * a single word at every TC0 overflow and to generate an interrupt
+ * at the end of the transfer.
+ * 
+ */
+void latchSequencerInit(void){
+    
+    // TC0: periodic trigger source
+    TC0_TimerStop();
+    TC0_REGS->COUNT16.TC_INTENCLR = (uint8_t) TC_INTENCLR_OVF_Msk;
+    TC0_REGS->COUNT16.TC_CTRLBCLR = (uint8_t) TC_CTRLBCLR_ONESHOT_Msk;
+    while((TC0_REGS->COUNT16.TC_SYNCBUSY & TC_SYNCBUSY_CTRLB_Msk) == TC_SYNCBUSY_CTRLB_Msk);
+    TC0_Timer16bitPeriodSet((uint16_t) (LATCH_US_PULSE * (TC0_TimerFrequencyGet() / 1000000) - 1));
+    
+    // DMAC module
+    MCLK_REGS->MCLK_AHBMASK |= MCLK_AHBMASK_DMAC_Msk;
+    DMAC_REGS->DMAC_CTRL &= (uint16_t) ~DMAC_CTRL_DMAENABLE_Msk;
+    DMAC_REGS->DMAC_CTRL = (uint16_t) DMAC_CTRL_SWRST_Msk;
+    while((DMAC_REGS->DMAC_CTRL & DMAC_CTRL_SWRST_Msk) == DMAC_CTRL_SWRST_Msk);
+    DMAC_REGS->DMAC_BASEADDR = (uint32_t) &latch_dma_base;
+    DMAC_REGS->DMAC_WRBADDR = (uint32_t) &latch_dma_wrb;
+    DMAC_REGS->DMAC_CTRL = (uint16_t) (DMAC_CTRL_DMAENABLE_Msk | DMAC_CTRL_LVLEN_Msk);
+    
+    // DMAC channel: a single beat for every TC0 overflow
+    DMAC_REGS->CHANNEL[LATCH_DMA_CHANNEL].DMAC_CHCTRLA = DMAC_CHCTRLA_SWRST_Msk;
+    while((DMAC_REGS->CHANNEL[LATCH_DMA_CHANNEL].DMAC_CHCTRLA & DMAC_CHCTRLA_SWRST_Msk) == DMAC_CHCTRLA_SWRST_Msk);
+    DMAC_REGS->CHANNEL[LATCH_DMA_CHANNEL].DMAC_CHCTRLA = DMAC_CHCTRLA_TRIGSRC(TC0_DMAC_ID_OVF) | DMAC_CHCTRLA_TRIGACT_BURST | DMAC_CHCTRLA_BURSTLEN_SINGLE;
+    DMAC_REGS->CHANNEL[LATCH_DMA_CHANNEL].DMAC_CHPRILVL = 0;
+    DMAC_REGS->CHANNEL[LATCH_DMA_CHANNEL].DMAC_CHINTENSET = DMAC_CHINTENSET_TCMPL_Msk;
+    
+    NVIC_SetPriority(DMAC_0_IRQn, 7);
+    NVIC_EnableIRQ(DMAC_0_IRQn);
+    
+    latch_pending = 0;
+    latch_running = 0;
+}
 
 /**
- * This function Latches the Motor Bus data to the Motor driver.
+ * This function builds and starts a latch sequence
+ * with all the pending latch requests.
  * 
- * The function evaluates the content of the  motor_latch[] 
- * variable, setting the BUS with the targeted motor bus data;
+ * For every pending motor, the sequence is made of four descriptors,
+ * each transferring a single word to a PORT register:
+ * + the BUS lines to be cleared (PORTA OUTCLR);
+ * + the BUS lines to be set (PORTA OUTSET);
+ * + the motor latch line rising edge (OUTSET);
+ * + the motor latch line falling edge (OUTCLR);
  * 
- * The function will latch the motor bus data pulsing (10us pulse)
- * the motor latch trigger line (uc_LATCH_Mx pin).  
- *  
- * @param motid this is the Motor identifier. (See _MOTOR_ID_t)
+ * Every transfer is triggered by the TC0 overflow, so the BUS data
+ * are stable for LATCH_US_PULSE before the latch rising edge and the 
+ * latch pulse lasts LATCH_US_PULSE.
+ * 
+ * The bus data are evaluated when the sequence is built:
+ * a request received during the sequence is served by the next sequence.
+ * 
+ * The function shall be called with the interrupts disabled
+ * or into the DMAC interrupt routine.
  */
-void setLatch(_MOTOR_ID_t motid){
+void latchSequencerStart(void){
+    int n = 0;
+    uint32_t bus, latch;
+    volatile uint32_t* dst[LATCH_DMA_STEPS];
+    
+    if(!latch_pending) return;
+    
+    for(int id=0; id < MOTOR_LEN; id++){
+        if(!(latch_pending & (1U << id))) continue;
         
-    // Set the BUS value before to latch the data to the target motor 
-    unsigned char bus = *((unsigned char*) &motor_latch[motid]);
-    if(bus & 0x1 ) uC_IA_Set();
-    else uC_IA_Clear();
-    if(bus & 0x2 ) uC_IB_Set();
-    else uC_IB_Clear();
-    if(bus & 0x4 ) uC_MS1_Set();
-    else uC_MS1_Clear();
-    if(bus & 0x8 ) uC_MS2_Set();
-    else uC_MS2_Clear();
-    if(bus & 0x10 ) uC_DIR_Set();
-    else uC_DIR_Clear();
-    if(bus & 0x20 ) uC_ENA_Set();
-    else uC_ENA_Clear();
-    if(bus & 0x40 ) uC_RST_Set();
-    else uC_RST_Clear();
-    if(bus & 0x80 ) uC_ENASTEP_Set();
-    else uC_ENASTEP_Clear();
-     
-    // Latches the target motor    
-    switch(motid){
-        case MOTOR_LEFT_ID: 
-            uC_LATCH_LEFT_Set();
-            wait_us(LATCH_US_PULSE);
-            uC_LATCH_LEFT_Clear();
-        break;
-        case MOTOR_RIGHT_ID: 
-            uC_LATCH_RIGHT_Set();
-            wait_us(LATCH_US_PULSE);
-            uC_LATCH_RIGHT_Clear();
-        break;
-        case MOTOR_FRONT_ID: 
-            uC_LATCH_FRONT_Set();
-            wait_us(LATCH_US_PULSE);
-            uC_LATCH_FRONT_Clear();
-        break;
-        case MOTOR_BACK_ID: 
-            uC_LATCH_BACK_Set();
-            wait_us(LATCH_US_PULSE);
-            uC_LATCH_BACK_Clear();
-        break;
-        case MOTOR_TRAP_ID: 
-            uC_LATCH_TRAP_Set();
-            wait_us(LATCH_US_PULSE);
-            uC_LATCH_TRAP_Clear();
-        break;
-        case MOTOR_MIRROR_ID: 
-            uC_LATCH_MIRROR_Set();
-            wait_us(LATCH_US_PULSE);
-            uC_LATCH_MIRROR_Clear();
-        break;
-        case MOTOR_FILTER_ID: 
-            uC_LATCH_FILTER_Set();
-            wait_us(LATCH_US_PULSE);
-            uC_LATCH_FILTER_Clear();
-        break;
+        bus = (uint32_t) *((unsigned char*) &motor_latch[id]) << LATCH_BUS_SHIFT;
+        latch = (uint32_t) 1U << (latch_pin[id] & 0x1F);
+        
+        latch_dma_data[n] = LATCH_BUS_MASK & ~bus;
+        latch_dma_data[n+1] = bus;
+        latch_dma_data[n+2] = latch;
+        latch_dma_data[n+3] = latch;
+        dst[0] = &PORT_REGS->GROUP[0].PORT_OUTCLR;
+        dst[1] = &PORT_REGS->GROUP[0].PORT_OUTSET;
+        dst[2] = &PORT_REGS->GROUP[latch_pin[id] >> 5].PORT_OUTSET;
+        dst[3] = &PORT_REGS->GROUP[latch_pin[id] >> 5].PORT_OUTCLR;
+        
+        for(int i=0; i < LATCH_DMA_STEPS; i++, n++){
+            latch_dma_list[n].DMAC_BTCTRL = (uint16_t) (DMAC_BTCTRL_VALID_Msk | DMAC_BTCTRL_BEATSIZE_WORD | DMAC_BTCTRL_BLOCKACT_NOACT);
+            latch_dma_list[n].DMAC_BTCNT = 1;
+            latch_dma_list[n].DMAC_SRCADDR = (uint32_t) &latch_dma_data[n];
+            latch_dma_list[n].DMAC_DSTADDR = (uint32_t) dst[i];
+            latch_dma_list[n].DMAC_DESCADDR = (uint32_t) &latch_dma_list[n+1];
+        }
+    }
+    
+    // The last descriptor terminates the transfer with the interrupt
+    latch_dma_list[n-1].DMAC_BTCTRL = (uint16_t) (DMAC_BTCTRL_VALID_Msk | DMAC_BTCTRL_BEATSIZE_WORD | DMAC_BTCTRL_BLOCKACT_INT);
+    latch_dma_list[n-1].DMAC_DESCADDR = 0;
+    latch_dma_base = latch_dma_list[0];
+    
+    latch_running = latch_pending;
+    latch_pending = 0;
+    
+    DMAC_REGS->CHANNEL[LATCH_DMA_CHANNEL].DMAC_CHCTRLA |= DMAC_CHCTRLA_ENABLE_Msk;
+    TC0_TimerStart();
+}
+
+/**
+ * This is the DMAC channel 0 interrupt routine.
+ * 
+ * The routine is called at the end of a latch sequence:
+ * + the TC0 trigger source is stopped;
+ * + the latch requests of the latched motors are cleared, 
+ * unless they have been requested again during the sequence;
+ * + a new sequence is started if requests are pending.
+ * 
+ */
+void DMAC_0_Handler(void){
+    DMAC_REGS->CHANNEL[LATCH_DMA_CHANNEL].DMAC_CHINTFLAG = DMAC_CHINTFLAG_TCMPL_Msk;
+    TC0_TimerStop();
+    
+    for(int id=0; id < MOTOR_LEN; id++){
+        if(!(latch_running & (1U << id))) continue;
+        if(latch_pending & (1U << id)) continue;
+        motor_latch_request[id] = false;
     }
+    
+    latch_running = 0;
+    latchSequencerStart();
 }
 
 /**
@@ -171,6 +264,7 @@ void motorOn(MOTOR_STRUCT_t* mot, MOT_ILIM_MODE_t torque, MOT_DIRECTION_t dir){
     motor_latch[mot->id].ILIM =   torque;
     motor_latch[mot->id].uSTEP =  mot->stepping_mode;
     motor_latch[mot->id].DIR = dir;
+    mot->direction = dir;
      
     motor_latch[mot->id].MOTENA = MOT_ENA_ON;
     motor_latch[mot->id].RST =    MOT_RST_OFF;
@@ -218,6 +312,9 @@ void motorHold(MOTOR_STRUCT_t* mot, MOT_ILIM_MODE_t torque){
  * 
  * When the Motor is set in disable mode, the motor driver is disabled
  * and the step sequencer is reset. No torque is applied!
+ * 
+ * Because the step sequencer is reset, the absolute position 
+ * of the motor is no more granted and it is invalidated.
  *  
  * @param motid Selects the target motor from MOTOR_M1 to MOTOR_M5; 
  */
@@ -230,6 +327,34 @@ void motorDisable(MOTOR_STRUCT_t* mot){
     motor_latch[mot->id].MOTENA = MOT_ENA_OFF;
     motor_latch[mot->id].RST =    MOT_RST_ON;
     motor_latch[mot->id].ENASTEP = MOT_ENASTEP_OFF;
+    
+    // The step sequencer reset invalidates the position
+    mot->position_valid = false;
+            
+    // Latches 
+    requestLatch(mot->id);
+}
+
+/**
+ * This function switches Off the motor at the end of a positioning.
+ * 
+ * The motor driver outputs are disabled (no torque is applied) 
+ * but the step sequencer is not reset: the motor phase is preserved so 
+ * that the absolute position of the motor remains valid 
+ * for the next activation.
+ *  
+ * @param mot Selects the target motor; 
+ */
+void motorRelease(MOTOR_STRUCT_t* mot){
+    
+    // Clears the step pin
+    motorStep(mot, false);
+    
+     // Set the motor bus lines
+    motor_latch[mot->id].ILIM =   MOT_TORQUE_DISABLE;
+    motor_latch[mot->id].MOTENA = MOT_ENA_OFF;
+    motor_latch[mot->id].RST =    MOT_RST_OFF;
+    motor_latch[mot->id].ENASTEP = MOT_ENASTEP_OFF;
             
     // Latches 
     requestLatch(mot->id);
@@ -238,16 +363,22 @@ void motorDisable(MOTOR_STRUCT_t* mot){
 /**
  * This functions initialize the Module:
  * 
- * + It is registered the TC0 callback;
+ * + The DWT cycle counter is enabled for the step pulse timing;
+ * + The latch sequencer is initialized;
  * + The Motor driver exits from the sleep mode;
  * + The Latch pins are cleared;
- * + The Motors are initialized with a disable mode;
+ * + The Motors are initialized with a disable mode (single latch sequence);
  * 
  */
 void motorLibInitialize(void){
 
-    // Register the callback for the TC0 timer
-    TC0_TimerCallbackRegister(latch_1us_callback,0);    
+    // Enables the DWT cycle counter
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    
+    // Initializes the DMAC latch sequencer
+    latchSequencerInit();
 
     // Latch reset High
     uC_LATCH_CLR_Set();
@@ -274,7 +405,7 @@ void motorLibInitialize(void){
         motor_latch[i].MOTENA = MOT_ENA_OFF;
         motor_latch[i].RST =    MOT_RST_ON;
         motor_latch[i].ENASTEP = MOT_ENASTEP_OFF;
-        setLatch(i);
+        requestLatch(i);
     }
     
     // Initializes the motor structures
@@ -286,6 +417,15 @@ void motorLibInitialize(void){
     mirrorMotorStruct.id = MOTOR_MIRROR_ID;
     filterMotorStruct.id = MOTOR_FILTER_ID;
     
+    // The absolute positions are unknown at the startup
+    rightMotorStruct.position_valid = false;
+    leftMotorStruct.position_valid = false;
+    backMotorStruct.position_valid = false;
+    frontMotorStruct.position_valid = false;
+    trapMotorStruct.position_valid = false;
+    mirrorMotorStruct.position_valid = false;
+    filterMotorStruct.position_valid = false;
+    
     
 }
 
@@ -304,47 +444,326 @@ bool optoGet(MOTOR_STRUCT_t* mot){
     return mot->opto_status;
 }
 
+/**
+ * This function requests a step pulse to a motor.
+ * 
+ * The step is counted and the absolute position is updated
+ * but the STEP output is not directly set: the pulse is generated
+ * by the motorStepComplete() function, together with the pulses of 
+ * all the motors sharing the same timer.
+ * 
+ * If stat is false the STEP output is immediately cleared.
+ * 
+ * @param mot pointer to the motor structure
+ * @param stat true to request a step pulse, false to clear the STEP output
+ */
 void motorStep(MOTOR_STRUCT_t* mot, bool stat){
     mot->step_polarity = stat;
     
     if(stat){
         mot->steps++;
-        switch(mot->id){
-            case MOTOR_LEFT_ID: uC_STEP_LEFT_Set();return;
-            case MOTOR_RIGHT_ID: uC_STEP_RIGHT_Set();return;
-            case MOTOR_FRONT_ID: uC_STEP_FRONT_Set();return;
-            case MOTOR_BACK_ID: uC_STEP_BACK_Set();return;
-            case MOTOR_TRAP_ID: uC_STEP_TRAP_Set();return;
-            case MOTOR_MIRROR_ID: uC_STEP_MIRROR_Set();return;
-            case MOTOR_FILTER_ID: uC_STEP_FILTER_Set();return;
+        
+        // Updates the absolute position
+        if(mot->direction == mot->direction_field) mot->position++;
+        else mot->position--;
+        return;
+    }
+    
+    STEP_PORT_GROUP(step_pin[mot->id]).PORT_OUTCLR = STEP_PORT_MASK(step_pin[mot->id]);
+    return ;
+}
+
+/**
+ * This function generates the step pulses of a group of motors 
+ * sharing the same timer.
+ * 
+ * The function shall be called at the end of the timer callback,
+ * after the positioning of all the motors of the group: 
+ * + the STEP pins of the motors with a pending step are collected 
+ * in a bitmask for every PORT group;
+ * + the rising edges are generated with a single OUTSET write per group;
+ * + after the minimum pulse width, the pulses are terminated 
+ * with a single OUTCLR write per group.
+ * 
+ * The pulse width (MOTOR_STEP_PULSE_US) is timed with the DWT cycle counter.
+ * 
+ * @param pMotors array of the motors sharing the timer
+ * @param len number of motors of the array
+ */
+void motorStepComplete(MOTOR_STRUCT_t* const pMotors[], int len){
+    uint32_t mask[STEP_PORT_GROUPS] = {0, 0};
+    
+    // Collects the pending steps
+    for(int i=0; i<len; i++){
+        if(!pMotors[i]->step_polarity) continue;
+        pMotors[i]->step_polarity = false;
+        mask[step_pin[pMotors[i]->id] >> 5] |= STEP_PORT_MASK(step_pin[pMotors[i]->id]);
+    }
+    if((mask[0] | mask[1]) == 0) return;
+    
+    // Simultaneous rising edges
+    PORT_REGS->GROUP[0].PORT_OUTSET = mask[0];
+    PORT_REGS->GROUP[1].PORT_OUTSET = mask[1];
+    
+    // Minimum pulse width
+    wait_cycles(MOTOR_STEP_PULSE_US * (CPU_CLOCK_FREQUENCY / 1000000));
+    
+    PORT_REGS->GROUP[0].PORT_OUTCLR = mask[0];
+    PORT_REGS->GROUP[1].PORT_OUTCLR = mask[1];
+}
+
+/**
+ * This is the motion profile engine shared by the positioning modules.
+ * 
+ * The function shall be called at every tick of the module timer, 
+ * before to execute the positioning sequence:
+ * + the step period is counted;
+ * + when the step period expires, the next period is calculated 
+ * following a trapezoidal profile.
+ * 
+ * The profile accelerates decreasing the period by ramp_rate
+ * at every step, from init_period to the cruise_period
+ * (the run_period unless the move is synchronized). 
+ * 
+ * If the move length is known (move_steps >= 0), 
+ * the braking distance is the number of steps necessary 
+ * to return to the init_period: when the remaining steps 
+ * are not greater than the braking distance, the period is increased 
+ * by ramp_rate at every step (symmetric deceleration).
+ * 
+ * When the move is completed, the period is set to the run_period
+ * so that the final holding time does not depend on the profile.
+ * 
+ * @param pMotor pointer to the motor structure
+ * @return true if the step period is expired and the positioning sequence shall be executed
+ */
+bool motorProfileUpdate(MOTOR_STRUCT_t* pMotor){
+    int remaining;
+    
+    // If the scheduled time is not expired no action will be taken
+    if(pMotor->time_count < pMotor->period){
+        pMotor->time_count++;
+        return false;
+    }
+    pMotor->time_count = 0; 
+    
+    // Deceleration handling
+    if(pMotor->move_steps >= 0){
+        remaining = pMotor->move_steps - pMotor->steps;
+        
+        // Move completed: the holding time is counted with the run period
+        if(remaining <= 0){
+            pMotor->period = pMotor->run_period;
+            return true;
         }
         
-    }else{
-        switch(mot->id){
-            case MOTOR_LEFT_ID: uC_STEP_LEFT_Clear();return;
-            case MOTOR_RIGHT_ID: uC_STEP_RIGHT_Clear();return;
-            case MOTOR_FRONT_ID: uC_STEP_FRONT_Clear();return;
-            case MOTOR_BACK_ID: uC_STEP_BACK_Clear();return;
-            case MOTOR_TRAP_ID: uC_STEP_TRAP_Clear();return;
-            case MOTOR_MIRROR_ID: uC_STEP_MIRROR_Clear();return;
-            case MOTOR_FILTER_ID: uC_STEP_FILTER_Clear();return;
+        // The remaining steps are into the braking distance
+        if(remaining <= (pMotor->init_period - pMotor->period) / pMotor->ramp_rate){
+            pMotor->period += pMotor->ramp_rate;
+            if(pMotor->period >= pMotor->init_period) pMotor->period = pMotor->init_period;
+            return true;
         }
     }
     
-    return ;
+    // Acceleration handling
+    pMotor->period -= pMotor->ramp_rate;
+    if(pMotor->period <= pMotor->cruise_period) pMotor->period = pMotor->cruise_period;
+    return true;
+}
+
+/**
+ * This function calculates the duration of a profiled move.
+ * 
+ * The duration is calculated with the same trapezoidal profile
+ * of the motorProfileUpdate() function, in closed form: 
+ * + the period of every step lasts (period + 1) ticks;
+ * + the acceleration lasts A steps from init_period 
+ * to the cruise period, with A = (init_period - cruise_period) / ramp_rate (rounded up);
+ * + the deceleration is symmetric;
+ * + if the move is shorter than 2A steps, the profile 
+ * is triangular and the cruise speed is not reached.
+ * 
+ * @param pMotor pointer to the motor structure
+ * @param steps length of the move
+ * @param cruise_period cruise period of the move
+ * @return the move duration in timer ticks
+ */
+int motorMoveTicks(MOTOR_STRUCT_t* pMotor, int steps, int cruise_period){
+    int r = pMotor->ramp_rate;
+    int p0 = pMotor->init_period + 1;
+    int a = (pMotor->init_period - cruise_period + r - 1) / r;
+    int ticks;
+    
+    if(steps <= 0) return 0;
+    
+    // Trapezoidal profile
+    if(steps >= 2 * a) return 2 * (a * p0 - r * a * (a - 1) / 2) + (steps - 2 * a) * (cruise_period + 1);
+    
+    // Triangular profile
+    a = steps / 2;
+    ticks = 2 * (a * p0 - r * a * (a - 1) / 2);
+    if(steps & 0x1) ticks += p0 - a * r;
+    return ticks;
+}
+
+/**
+ * This function synchronizes the arrival of a group of motors.
+ * 
+ * The function shall be called after the motor activations,
+ * before to start the module timer.
+ * 
+ * Only the motors with a known move length (move_steps > 0) 
+ * are synchronized: the longest move, executed at the run_period,
+ * is the reference time and the cruise period of the other motors 
+ * is set to the slowest value completing the move in the reference time.
+ * 
+ * @param pMotors array of the motors sharing the timer
+ * @param len number of motors of the array
+ * @return the expected move duration in timer ticks
+ */
+int motorSynchronize(MOTOR_STRUCT_t* const pMotors[], int len){
+    int reference = 0;
+    int ticks, lo, hi, mid;
+    
+    // Finds the reference time
+    for(int i=0; i<len; i++){
+        if(!pMotors[i]->command_running) continue;
+        if(pMotors[i]->move_steps <= 0) continue;
+        ticks = motorMoveTicks(pMotors[i], pMotors[i]->move_steps, pMotors[i]->run_period);
+        if(ticks > reference) reference = ticks;
+    }
+    
+    // Scales the cruise period of every motor
+    for(int i=0; i<len; i++){
+        if(!pMotors[i]->command_running) continue;
+        if(pMotors[i]->move_steps <= 0) continue;
+        
+        // Finds the maximum cruise period within the reference time
+        lo = pMotors[i]->run_period;
+        hi = pMotors[i]->init_period;
+        while(lo < hi){
+            mid = (lo + hi + 1) / 2;
+            if(motorMoveTicks(pMotors[i], pMotors[i]->move_steps, mid) <= reference) lo = mid;
+            else hi = mid - 1;
+        }
+        pMotors[i]->cruise_period = lo;
+    }
+    
+    return reference;
+}
+
+/**
+ * This function calculates the time of the next event of a group
+ * of motors sharing the same timer.
+ * 
+ * For every running motor, the number of ticks to its next event is
+ * the number of ticks to the step period expiration.
+ * 
+ * The function returns the minimum value along the running motors
+ * and advances the tick counter of every running motor
+ * of the ticks that will be skipped before the next event. 
+ * 
+ * @param pMotors array of the motors sharing the timer
+ * @param len number of motors of the array
+ * @return the number of ticks to the next event or 0 if no motor is running
+ */
+int motorProfileSchedule(MOTOR_STRUCT_t* const pMotors[], int len){
+    int ticks = MOTOR_MAX_EVENT_TICKS;
+    int motor_ticks;
+    bool running = false;
+    
+    // Finds the soonest event
+    for(int i=0; i<len; i++){
+        if(!pMotors[i]->command_running) continue;
+        running = true;
+        
+        if(pMotors[i]->time_count >= pMotors[i]->period) motor_ticks = 1;
+        else motor_ticks = pMotors[i]->period - pMotors[i]->time_count + 1;
+        
+        if(motor_ticks < ticks) ticks = motor_ticks;
+    }
+    
+    if(!running) return 0;
+    
+    // Advances the motor tick counters of the skipped ticks
+    for(int i=0; i<len; i++){
+        if(!pMotors[i]->command_running) continue;
+        pMotors[i]->time_count += ticks - 1;
+    }
+    
+    return ticks;
+}
+
+/**
+ * This function programs the timer of a positioning module 
+ * to generate the next period event after a given number of ticks.
+ * 
+ * The function shall be called into the timer callback,
+ * after the period event: the compare register is directly 
+ * updated so that the running period expires after the requested ticks. 
+ * 
+ * The function shall be called also before to start the timer,
+ * in order to generate the first event after a single tick.
+ * 
+ * In case the counter already passed the new compare value,
+ * the counter is moved to the compare value 
+ * so that the event is generated immediately. 
+ * 
+ * @param tc pointer to the TC module registers
+ * @param tick_period this is the compare value of a single tick
+ * @param ticks number of ticks to the next event
+ */
+void motorTimerSchedule(tc_registers_t* tc, unsigned short tick_period, int ticks){
+    uint32_t period;
+    
+    if(ticks < 1) ticks = 1;
+    if(ticks > MOTOR_MAX_EVENT_TICKS) ticks = MOTOR_MAX_EVENT_TICKS;
+    period = (uint32_t) ticks * ((uint32_t) tick_period + 1) - 1;
+    
+    // Sets the new period
+    tc->COUNT16.TC_CC[0] = (uint16_t) period;
+    while((tc->COUNT16.TC_SYNCBUSY & TC_SYNCBUSY_CC0_Msk) == TC_SYNCBUSY_CC0_Msk);
+    
+    // Reads the current counter
+    tc->COUNT16.TC_CTRLBSET = (uint8_t)TC_CTRLBSET_CMD_READSYNC;
+    while((tc->COUNT16.TC_SYNCBUSY & TC_SYNCBUSY_CTRLB_Msk) == TC_SYNCBUSY_CTRLB_Msk);
+    while((tc->COUNT16.TC_CTRLBSET & TC_CTRLBSET_CMD_Msk) != 0U);
+    
+    // The event is already expired: it is generated immediately
+    if(tc->COUNT16.TC_COUNT >= period){
+        tc->COUNT16.TC_COUNT = (uint16_t) period;
+        while((tc->COUNT16.TC_SYNCBUSY & TC_SYNCBUSY_COUNT_Msk) == TC_SYNCBUSY_COUNT_Msk);
+    }
+    
+    return;
 }
 
 bool isLatched(MOTOR_STRUCT_t* mot){
     return !motor_latch_request[mot->id];
 }
 
-void activationInitialize(MOTOR_STRUCT_t* pMotor, bool start_tc){
+/**
+ * This function initializes and starts a motor activation.
+ * 
+ * The ramp is initialized, the motor is activated 
+ * in the requested direction and the positioning sequence
+ * is started from the given sequence index. 
+ * 
+ * @param pMotor pointer to the motor structure
+ * @param sequence this is the initial sequence index
+ * @param dir this is the activation direction
+ * @param start_tc true if the module timer shall be started
+ */
+void activationStart(MOTOR_STRUCT_t* pMotor, int sequence, MOT_DIRECTION_t dir, bool start_tc){
 
     // Initializes the ramp
     pMotor->time_count = 0; 
     pMotor->period = pMotor->init_period;
-    pMotor->command_sequence = 1;
-    motorOn(pMotor, MOT_TORQUE_HIGH, pMotor->direction_home );    
+    pMotor->steps = 0;
+    pMotor->move_steps = -1;
+    pMotor->cruise_period = pMotor->run_period;
+    pMotor->command_sequence = sequence;
+    motorOn(pMotor, MOT_TORQUE_HIGH, dir );    
 
     pMotor->command_running = true;
     pMotor->command_error = 0;
@@ -363,6 +782,42 @@ void activationInitialize(MOTOR_STRUCT_t* pMotor, bool start_tc){
     return ;
 }
 
+/**
+ * This function starts a positioning with the zero setting.
+ * 
+ * The motor is activated in the home direction, starting 
+ * from the sequence 1 of the module positioning procedure.
+ * 
+ * @param pMotor pointer to the motor structure
+ * @param start_tc true if the module timer shall be started
+ */
+void activationInitialize(MOTOR_STRUCT_t* pMotor, bool start_tc){
+    activationStart(pMotor, 1, pMotor->direction_home, start_tc);
+}
+
+/**
+ * This function starts a direct positioning from the current 
+ * absolute position to the target_steps position.
+ * 
+ * The motor is activated in the direction of the target and 
+ * the positioning procedure of the module starts from the given sequence.
+ * 
+ * The function shall be called only when the position is valid.
+ * 
+ * @param pMotor pointer to the motor structure
+ * @param sequence this is the sequence index of the module target positioning
+ * @param start_tc true if the module timer shall be started
+ */
+void activationPosition(MOTOR_STRUCT_t* pMotor, int sequence, bool start_tc){
+    if(pMotor->target_steps >= pMotor->position){
+        activationStart(pMotor, sequence, pMotor->direction_field, start_tc);
+        pMotor->move_steps = pMotor->target_steps - pMotor->position;
+    }else{
+        activationStart(pMotor, sequence, pMotor->direction_home, start_tc);
+        pMotor->move_steps = pMotor->position - pMotor->target_steps;
+    }
+}
+
 _MOTOR_COMMAND_RETURN_t activateMotor(unsigned short steps, MOTOR_STRUCT_t* pMotor){
     
     if(pMotor->command_running) return MOT_RET_ERR_BUSY;
@@ -423,6 +878,7 @@ void motorTestActivation(unsigned char test_case){
     if(test_case)  motorOn(pMotor, MOT_TORQUE_HIGH, pMotor->direction_home );
     else{ 
         motorStep(pMotor, stat);
+        if(stat) motorStepComplete(&pMotor, 1);
         stat = !stat;
     }
 }
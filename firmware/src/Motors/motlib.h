@@ -85,6 +85,91 @@
  * The module control the driver current limitation through two digital
  * lines of the control BUS 
  * 
+ * ### Latch Timing
+ * 
+ * The motor bus data are latched by a DMAC sequencer:
+ * the latch requests are collected and played as a list of 
+ * PORT write descriptors (bus clear, bus set, latch high, latch low
+ * for every motor), paced by the TC0 overflow every LATCH_US_PULSE.
+ * A single DMAC interrupt is generated at the end of the sequence,
+ * when the requests are marked as latched (see isLatched()).
+ * 
+ * The latch of all the seven motors (at the startup or in the abort procedure) 
+ * then takes a bounded time (4 x LATCH_US_PULSE for every motor)
+ * without CPU activity.
+ * 
+ * ## Absolute Position
+ * 
+ * Every motor structure keeps the absolute position of the motor axe, 
+ * counted in steps from the zero reference (the photocell exit edge).
+ * 
+ * The position becomes valid as soon as the zero setting is completed
+ * and it is kept valid at the end of the positioning 
+ * with the motorRelease() function, that switches off the driver 
+ * without resetting the step sequencer.
+ * 
+ * The motorDisable() function resets the step sequencer, so it invalidates
+ * the position: the next activation will execute the zero setting again.
+ * 
+ * ## Motion Profile
+ * 
+ * The motorProfileUpdate() function implements the trapezoidal speed profile
+ * shared by all the positioning modules. It shall be called at every timer tick:
+ * + the step period is decreased by ramp_rate at every step, 
+ * from init_period to run_period;
+ * + when the move length is known (move_steps >= 0), the period is increased by ramp_rate 
+ * at every step as soon as the remaining steps are not greater than 
+ * the braking distance, so the motor reaches the target at the initial speed;
+ * + when the move is completed, the period is set to run_period 
+ * to time the final holding phase.
+ * 
+ * ## Synchronized Arrival
+ * 
+ * A group of motors moving directly to their targets (move length known)
+ * can be synchronized with the motorSynchronize() function:
+ * + the duration of every move is calculated with the run_period 
+ * as cruise period (see motorMoveTicks());
+ * + the longest move is taken as reference;
+ * + the cruise period of every other motor is increased 
+ * to the slowest value that still completes the move within the reference time. 
+ * 
+ * All the motors then reach the target at the same time
+ * (within a step period), the peak current is reduced and 
+ * the command completion time is known in advance.
+ * 
+ * ## Event Scheduling
+ * 
+ * The module timers are not programmed with a fixed tick rate:
+ * after every event, the motorProfileSchedule() function calculates the number 
+ * of ticks to the next step edge of the soonest motor of the group, and the 
+ * motorTimerSchedule() function programs the timer compare to expire 
+ * exactly at that time. The tick counters of the other motors are 
+ * advanced of the skipped ticks, so the motion timing is not changed, 
+ * but the timer interrupt is generated only when a motor has something to do.
+ * 
+ * ## Step Pulse Generation
+ * 
+ * Every step is a complete pulse generated into a single timer event:
+ * + the motorStep() function counts the step and marks it as pending;
+ * + at the end of the timer callback, the motorStepComplete() function 
+ * collects the pending steps of all the motors of the group 
+ * into a bitmask per PORT group, sets all the STEP outputs with a single
+ * OUTSET write, waits the minimum pulse width (MOTOR_STEP_PULSE_US) 
+ * and clears them with a single OUTCLR write.
+ * 
+ * The rising edges of the motors stepping in the same event are then 
+ * simultaneous and the cost of the pulse generation does not depend
+ * on the number of stepping motors.
+ * 
+ * The step period is then counted on a single timer tick unit:
+ * a step is generated every (period + 1) ticks. The pulse width
+ * is shared by all the motors stepping in the same event, so it 
+ * is paid once per callback.
+ * 
+ * The STEP lines are assigned to GPIO pins without timer 
+ * waveform outputs (PB00, PB03 have no TC/TCC output), so the 
+ * pulse cannot be delegated to the timer hardware.
+ * 
  */
 
         /// This enumeration type defines the Motor Current Limit levels
@@ -104,7 +189,7 @@
         }MOT_MICROSTEP_t;
         static const unsigned char ustep[4] = {1,2,4,16};
         
-        #define MICROSTEP(x) (((unsigned char) x) < 4) ? ustep[(unsigned char) x] : 1
+        #define MICROSTEP(x) ((((unsigned char) x) < 4) ? ustep[(unsigned char) x] : 1)
 
         /** This enumeration type defines the activation direction
          *  
@@ -136,6 +221,8 @@
         }MOT_ENASTEP_t;
 
         #define MOTOR_LEN 7 //!< Defines the maximum number of implemented motors
+        #define MOTOR_STEP_PULSE_US 2 //!< Minimum STEP pulse width in us (driver specification: 1us)
+        #define MOTOR_MAX_EVENT_TICKS 2000 //!< Maximum number of timer ticks between two scheduled events
         
         /// This enumeration type defines the identifier of the stepper motors
         typedef enum{
@@ -175,7 +262,7 @@
             int id;     //!< Motor Id 
             unsigned short steps;  //!< Number of steps executed in the current positioning
             unsigned short target_steps;   //!< This is the target position
-            bool step_polarity;//!< This is the status of the STEP output pin
+            bool step_polarity;//!< This is the status of the STEP output pin (true: a pulse is waiting to be completed)
 
             // Ramp implementation
             int period; //!< The current pwm period
@@ -183,10 +270,17 @@
             int init_period; //!< This is the innitial period for the ramp            
             int ramp_rate; //!< decrement rate
             int run_period;    //!< Minimum period (speed)
+            int move_steps;    //!< Length in steps of the current profiled move (-1 if not known: no deceleration)
+            int cruise_period; //!< Cruise period of the current move (run_period unless synchronized)
             
             MOT_DIRECTION_t direction_home; //!< This is the setup direction for home
             MOT_DIRECTION_t direction_field;//!< This is the setup direction for field
             MOT_MICROSTEP_t stepping_mode;//!< This is the setup stepping mode
+            MOT_DIRECTION_t direction; //!< This is the current activation direction
+            
+            // Absolute position handling
+            int  position;          //!< Absolute position in steps from the zero reference (photocell exit edge)
+            bool position_valid;    //!< The absolute position is valid (the zero reference has been executed)
             
             int     command_error;   //!< error code if > 0
             bool    command_running; //!< true if the positioning is not completed
@@ -197,7 +291,7 @@
         }MOTOR_STRUCT_t;
         
         ext _MOTOR_DATA_t motor_latch[MOTOR_LEN]; //!< Array of the Motor Bus lines
-        ext bool motor_latch_request[MOTOR_LEN]; //!< Array of the Motor Bus line request
+        ext volatile bool motor_latch_request[MOTOR_LEN]; //!< Array of the Motor Bus line request (true while the latch is in progress)
         
         ext MOTOR_STRUCT_t leftMotorStruct;
         ext MOTOR_STRUCT_t rightMotorStruct;
@@ -208,16 +302,24 @@
         ext MOTOR_STRUCT_t filterMotorStruct;
 
         ext void motorLibInitialize(void); //!< Module initialization function        
-        ext void manageMotorLatch(void);
         
         ext bool isLatched(MOTOR_STRUCT_t* mot);
         ext void motorDisable(MOTOR_STRUCT_t* mot);//!< Disables the motor
         ext void motorOn(MOTOR_STRUCT_t* mot, MOT_ILIM_MODE_t torque, MOT_DIRECTION_t dir);//!< Activate the motor in a defined mode
         ext void motorHold(MOTOR_STRUCT_t* mot, MOT_ILIM_MODE_t torque); //!< Switch Off the motor with an active torque
+        ext void motorRelease(MOTOR_STRUCT_t* mot);//!< Switch Off the motor keeping the step sequencer position
         ext void motorStep(MOTOR_STRUCT_t* mot, bool stat);        
+        ext void motorStepComplete(MOTOR_STRUCT_t* const pMotors[], int len);//!< Generates the step pulses of a group of motors
         ext bool optoGet(MOTOR_STRUCT_t* mot);
         
+        ext bool motorProfileUpdate(MOTOR_STRUCT_t* pMotor);//!< Motion profile engine: returns true when a new step slot is expired
+        ext int  motorProfileSchedule(MOTOR_STRUCT_t* const pMotors[], int len);//!< Returns the ticks to the next event of a group of motors
+        ext void motorTimerSchedule(tc_registers_t* tc, unsigned short tick_period, int ticks);//!< Programs the timer for the next event
+        ext int  motorMoveTicks(MOTOR_STRUCT_t* pMotor, int steps, int cruise_period);//!< Returns the duration in ticks of a profiled move
+        ext int  motorSynchronize(MOTOR_STRUCT_t* const pMotors[], int len);//!< Synchronizes the arrival of a group of motors
+        
         ext void activationInitialize(MOTOR_STRUCT_t* pMotor, bool start_tc);
+        ext void activationPosition(MOTOR_STRUCT_t* pMotor, int sequence, bool start_tc);
         
         ext void abortActivation(void);
         ext _MOTOR_COMMAND_RETURN_t activateMotor(unsigned short steps, MOTOR_STRUCT_t* pMotor);
@@ -64,7 +64,7 @@ void ApplicationProtocolCommandHandler(uint8_t cmd, uint8_t d0,uint8_t d1,uint8_
         
         case CMD_SET_FORMAT:
             
-            switch(activateFormatCollimation(d0)){
+            switch(activateFormatCollimation(d0, (d1 & 0x1))){
                 case MOT_RET_IN_TARGET:
                     MET_Can_Protocol_returnCommandExecuted(d0,0);
                     break;
@@ -489,7 +489,7 @@ typedef enum{
 /// This is the list of the implemented COMMANDS
 typedef enum{
    CMD_ABORT = 0,      //!< Abort Command
-   CMD_SET_FORMAT = 1, //!< MAIN-CPU requests for a standard 2D collimation
+   CMD_SET_FORMAT = 1, //!< MAIN-CPU requests for a standard 2D collimation (d0: format index, d1.0: force the blades zero setting)
    CMD_SET_FILTER = 2, //!< MAIN-CPU requests for filter selection
    CMD_SET_MIRROR = 3, //!< MAIN-CPU requests for Mirror activation
    CMD_SET_LIGHT = 4,  //!< MAIN-CPU requests for Light activation
@@ -82,7 +82,6 @@ int main ( void )
         // Timer events activated into the RTC interrupt
         if(trigger_time & _7820_us_TriggerTime){
             trigger_time &=~ _7820_us_TriggerTime;
-            manageMotorLatch();
             manageTestButton();
         }
 